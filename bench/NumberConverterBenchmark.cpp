@@ -0,0 +1,92 @@
+// Compares NumberConverter with the std::stoi / std::ostringstream /
+// std::to_string calls it replaced.
+// g++ -std=c++17 -O2 -o NumberConverterBenchmark bench/NumberConverterBenchmark.cpp src/NumberConverter.cpp
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/NumberConverter.h"
+
+template <typename F>
+static double measure(const char* name, F f)
+{
+  const auto start = std::chrono::steady_clock::now();
+  const long long checksum = f();
+  const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << name << ": " << elapsed.count() << " ms (checksum " << checksum << ")\n";
+  return elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+  const int count = argc > 1 ? std::stoi(argv[1]) : 1000000;
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<int> dist(-1000000, 1000000);
+  std::vector<int> values(count);
+  std::vector<std::string> strings(count);
+  for (int i = 0; i < count; ++i) {
+    values[i] = dist(rng);
+    strings[i] = std::to_string(values[i]);
+  }
+
+  std::cout << "parse " << count << " values\n";
+  const double stoiTime = measure("  std::stoi             ", [&] {
+    long long sum = 0;
+    for (const auto& s : strings) {
+      sum += std::stoi(s);
+    }
+    return sum;
+  });
+  const double parseTime = measure("  NumberConverter::parse", [&] {
+    long long sum = 0;
+    for (const auto& s : strings) {
+      int v = 0;
+      NumberConverter::parse(s, v);
+      sum += v;
+    }
+    return sum;
+  });
+
+  std::cout << "format " << count << " values\n";
+  const double streamTime = measure("  std::ostringstream       ", [&] {
+    long long size = 0;
+    for (int v : values) {
+      std::ostringstream s;
+      s << v;
+      size += s.str().size();
+    }
+    return size;
+  });
+  measure("  std::to_string           ", [&] {
+    long long size = 0;
+    for (int v : values) {
+      size += std::to_string(v).size();
+    }
+    return size;
+  });
+  const double toStringTime = measure("  NumberConverter::toString", [&] {
+    long long size = 0;
+    for (int v : values) {
+      size += NumberConverter::toString(v).size();
+    }
+    return size;
+  });
+  measure("  NumberConverter::append  ", [&] {
+    std::string line;
+    long long size = 0;
+    for (int v : values) {
+      line.clear();
+      NumberConverter::append(line, v);
+      size += line.size();
+    }
+    return size;
+  });
+
+  std::cout << "speedup: parse " << stoiTime / parseTime
+            << "x, format " << streamTime / toStringTime << "x\n";
+  return 0;
+}
@@ -0,0 +1,92 @@
+// libFuzzer entry point for the cell parser and evaluator. The input is read
+// as a sheet (rows split by '\n', cells by '\t') of a two sheet workbook and
+// calculated by ReferenceGraph.
+// clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address,undefined -o ParserFuzzer fuzz/ParserFuzzer.cpp src/*.cpp
+// Without libFuzzer, a driver running the files given on the command line:
+// g++ -std=c++17 -g -fsanitize=address,undefined -DPARSER_FUZZER_MAIN -o ParserFuzzer fuzz/ParserFuzzer.cpp src/*.cpp
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/Cell.h"
+#include "../src/ReferenceGraph.h"
+
+static const size_t maxRows = 32;
+static const size_t maxColumns = 8;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  std::vector<std::vector<std::string>> grid(1);
+  for (size_t i = 0; i < size; ++i) {
+    const char c = (char)data[i];
+    if (c == '\n') {
+      if (grid.size() == maxRows) {
+        break;
+      }
+      grid.emplace_back();
+      continue;
+    }
+    if (grid.back().empty() || c == '\t') {
+      if (grid.back().size() == maxColumns) {
+        continue;
+      }
+      grid.back().emplace_back();
+      if (c == '\t') {
+        continue;
+      }
+    }
+    grid.back().back() += c;
+  }
+
+  // sheet S holds the input, sheet T a single number for S!/T! references
+  Cell::mWorkbook workbook;
+  Cell::mSpreadsheet& cells = workbook["S"];
+  Cell::mSpreadsheet& other = workbook["T"];
+  other['A'].push_back(Cell::createCell("1", other, workbook, std::make_pair('A', 1)));
+  try {
+    for (size_t column = 0; column < maxColumns; ++column) {
+      const char l = (char)('A' + column);
+      for (size_t row = 0; row < grid.size(); ++row) {
+        if (column >= grid[row].size()) {
+          continue;
+        }
+        const int position = (int)cells[l].size() + 1;
+        cells[l].push_back(Cell::createCell(grid[row][column], cells, workbook, std::make_pair(l, position)));
+      }
+    }
+  } catch (const std::runtime_error& e) {
+    // rejected cell data (non printable characters), as readSheet rejects the file
+    return 0;
+  }
+
+  ReferenceGraph graph(workbook);
+  graph.calculate(nullptr);
+  for (const auto& column : cells) {
+    for (const auto& cell : column.second) {
+      const std::string value = cell->getValue();
+      (void)value;
+    }
+  }
+  return 0;
+}
+
+#ifdef PARSER_FUZZER_MAIN
+int main(int argc, char* argv[])
+{
+  for (int i = 1; i < argc; ++i) {
+    std::ifstream file(argv[i], std::ios::binary);
+    std::ostringstream s;
+    s << file.rdbuf();
+    const std::string data = s.str();
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+  }
+  std::cout << "ParserFuzzer: " << argc - 1 << " input(s)\n";
+  return 0;
+}
+#endif
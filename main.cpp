@@ -1,15 +1,65 @@
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 #include "./src/Cell.h"
+#include "./src/NumberConverter.h"
 #include "./src/SpreadsheetCalculator.h"
 
 int main(int argc, char *argv[]) {
-  if (argc != 3) {
+  // invalid sheet names and unreadable or malformed input files
+  try {
+    // -j <threads>: 1 evaluates serially, to compare against the parallel run
+    // -r: recursive reference engine, to compare against ReferenceGraph
+    int threads = 0;
+    SpreadsheetCalculator::Engine engine = SpreadsheetCalculator::GRAPH;
+    while (argc > 1 && (std::string(argv[1]) == "-j" || std::string(argv[1]) == "-r")) {
+      if (std::string(argv[1]) == "-r") {
+        engine = SpreadsheetCalculator::REFERENCE;
+        argc -= 1;
+        argv += 1;
+        continue;
+      }
+      if (argc < 3
+        || !NumberConverter::parse(argv[2], argv[2] + std::string(argv[2]).size(), threads)
+        || threads < 0)
+      {
+        return 1;
+      }
+      argc -= 2;
+      argv += 2;
+    }
+    // workbook: -w <name> <input> <output> [<name> <input> <output> ...]
+    if (argc > 1 && std::string(argv[1]) == "-w") {
+      if (argc < 5 || (argc - 2) % 3 != 0) {
+        return 1;
+      }
+      SpreadsheetCalculator calculater;
+      calculater.setEngine(engine);
+      calculater.setThreadCount(threads);
+      for (int i = 2; i < argc; i += 3) {
+        calculater.addSheet(argv[i], argv[i + 1], argv[i + 2]);
+      }
+      calculater.readDataFromInputFile();
+      calculater.writeCalculatedDataToOutputFile();
+      return 0;
+    }
+    if (argc != 3 && argc != 4) {
+      return 1;
+    }
+    SpreadsheetCalculator calculater(argv[1], argv[2]);
+    calculater.setEngine(engine);
+    calculater.readDataFromInputFile();
+    if (argc == 4) {
+      // argv[3] is a previous output, only the changed cells are written
+      calculater.readSnapshotFromFile(argv[3]);
+      calculater.writeChangesToOutputFile();
+    } else {
+      calculater.writeCalculatedDataToOutputFile();
+    }
+  } catch (const std::runtime_error& e) {
+    std::cerr << e.what() << '\n';
     return 1;
   }
-  SpreadsheetCalculator calculater(argv[1], argv[2]);
-  calculater.readDataFromInputFile();
-  calculater.writeCalculatedDataToOutputFile();
   return 0;
 }
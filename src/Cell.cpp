@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <regex>
+#include <stdexcept>
 #include <iostream>
 
 #include "./Cell.h"
+#include "./NumberConverter.h"
 #include "./SpreadsheetCalculator.h"
 
 
@@ -10,19 +13,21 @@ const std::string Cell::errorFormat = "#UNKNOWN_FORMAT";
 const std::string Cell::errorExpressionEvaluation = "#TEXT?";
 const std::string Cell::errorReferenceCycling = "#CIRCULAR_REF";
 const std::string Cell::errorFormulaEntered = "#WRONG_FORMULA_TYPE";
+const std::string Cell::errorDivisionByZero = "#ERROR_NUM";
 
 bool Cell::isDataError(const std::string& cellData)
 {
     return cellData == errorFormat
           || cellData == errorExpressionEvaluation
           || cellData == errorReferenceCycling
-          || cellData == errorFormulaEntered;
+          || cellData == errorFormulaEntered
+          || cellData == errorDivisionByZero;
 }
 
 Cell::~Cell()
 {}
 
-std::shared_ptr<Cell> Cell::createCell(const std::string& cellData, const mSpreadsheet& cells, std::pair<char, int> pos)
+std::shared_ptr<Cell> Cell::createCell(const std::string& cellData, const mSpreadsheet& cells, const mWorkbook& workbook, std::pair<char, int> pos)
 {
     switch (getCellType(cellData)) {
       case EMPTY:
@@ -32,11 +37,11 @@ std::shared_ptr<Cell> Cell::createCell(const std::string& cellData, const mSprea
       case TEXT:
         return std::shared_ptr<Cell>(new TextCell(cellData, cells, TEXT));
       case EXPRESSION:
-        return std::shared_ptr<Cell>(new ExpressionCell(cellData, cells, EXPRESSION, pos));
+        return std::shared_ptr<Cell>(new ExpressionCell(cellData, cells, workbook, EXPRESSION, pos));
       case REFERANCE:
-        return std::shared_ptr<Cell>(new ExpressionCell(cellData, cells, REFERANCE, pos));
+        return std::shared_ptr<Cell>(new ExpressionCell(cellData, cells, workbook, REFERANCE, pos));
       default: {
-        throw "Error: Invalid Cell Data Type!";
+        throw std::runtime_error("Err: Invalid cell data!");
       }
     }
 }
@@ -51,7 +56,7 @@ bool Cell::isDataText(const std::string& cellData)
 {
     for (auto i : cellData)
     {
-      if (!std::isprint(i)) {
+      if (!std::isprint(static_cast<unsigned char>(i))) {
         return false;
       }
     }
@@ -100,6 +105,8 @@ Cell::Type Cell::getCellType(const std::string& cellData)
     if (isDataText(cellData)) {
       return TEXT;
     }
+    // e.g. control characters or non ASCII bytes
+    throw std::runtime_error("Err: Invalid cell data!");
 }
 
 
@@ -129,6 +136,7 @@ const std::string EmptyCell::getValue() const
 /* ----------------------- TextCell -----------------------*/
 TextCell::TextCell(const std::string& cellData, const mSpreadsheet& cells, Type type)
     : m_value(cellData)
+    , m_data(cellData)
     , m_type(type)
 {}
 
@@ -137,10 +145,11 @@ TextCell::~TextCell()
 
 void TextCell::calculate()
 {
-    if (m_value[0] != '\'') {
+    // from the original data, a sheet may be calculated more than once
+    if (m_data[0] != '\'') {
       m_value = errorFormat;
     } else {
-      m_value.erase(0, 1);
+      m_value = m_data.substr(1);
     }
 }
 
@@ -157,6 +166,7 @@ const std::string TextCell::getValue() const
 /* ----------------------- NumberCell -----------------------*/
 NumberCell::NumberCell(const std::string& cellData, const mSpreadsheet& cells, Type type)
     : m_value(cellData)
+    , m_data(cellData)
     , m_type(type)
 {}
 
@@ -165,6 +175,7 @@ NumberCell::~NumberCell()
 
 void NumberCell::calculate()
 {
+    m_value = m_data;
     m_value.erase(0, m_value.find_first_not_of('0'));
 }
 
@@ -179,12 +190,13 @@ const std::string NumberCell::getValue() const
 }
 
 /* ----------------------- ExpressionCell --------------------*/
-ExpressionCell::ExpressionCell(const std::string& cellData, const mSpreadsheet& cells, Type type, std::pair<char, int> pos)
+ExpressionCell::ExpressionCell(const std::string& cellData, const mSpreadsheet& cells, const mWorkbook& workbook, Type type, std::pair<char, int> pos)
     : m_value(cellData)
     , m_data(cellData)
     , m_type(type)
     , m_isCalculated(false)
     , m_cells(cells)
+    , m_workbook(workbook)
     , m_cellPosition(pos)
 {}
 
@@ -193,8 +205,11 @@ ExpressionCell::~ExpressionCell()
 
 void ExpressionCell::calculate()
 {
+    if (m_isCalculated) {
+      return;
+    }
     std::vector<std::string> tokens = m_type != EXPRESSION
-                                  ? referanceExpressionTokenize(getCellPosition(), m_data)
+                                  ? referanceExpressionTokenize(m_data)
                                   : simpleExpressionTokenize(m_data);
     if (m_isCalculated) {
       return;
@@ -205,37 +220,51 @@ void ExpressionCell::calculate()
       return;
     }
 
-    std::stack<std::string> st;
-    for (const auto token : m_tokens) {
+    // int arithmetic wraps around like the previous string based evaluation,
+    // done on unsigned values so that overflow is defined
+    std::stack<int> st;
+    for (const auto& token : m_tokens) {
       if (!isOperator(token)) {
-        st.push(token);
+        int d = 0;
+        if (!NumberConverter::parse(token, d)) {
+          m_value = errorExpressionEvaluation;
+          return;
+        }
+        st.push(d);
       } else {
+        if (st.empty()) {
+          m_value = errorFormulaEntered;
+          return;
+        }
         int result = 0;
-        const std::string val2 = st.top();
+        const int d2 = st.top();
+        const unsigned int u2 = d2;
         st.pop();
-        const int d2 = std::stoi(val2);
         if (!st.empty()) {
-          const std::string val1 = st.top();
+          const int d1 = st.top();
+          const unsigned int u1 = d1;
           st.pop();
-          const int d1 = std::stoi(val1);
           //Get the result
           if (0 == d2 && token == "/") {
-            m_value = "#ERROR_NUM";
+            m_value = errorDivisionByZero;
             return;
           }
-          result = token == "+" ? d1 + d2 :
-                   token == "-" ? d1 - d2 :
-                   token == "*" ? d1 * d2 :
+          result = token == "+" ? (int)(u1 + u2) :
+                   token == "-" ? (int)(u1 - u2) :
+                   token == "*" ? (int)(u1 * u2) :
+                   d2 == -1     ? (int)(0u - u1) :
                                   d1 / d2;
         } else {
-          result = token == "-" ? (d2 * -1) : d2;
+          result = token == "-" ? (int)(0u - u2) : d2;
         }
-        std::ostringstream s;
-        s << result;
-        st.push(s.str());
+        st.push(result);
       }
     }
-    m_value = st.top();
+    if (st.empty()) {
+      m_value = errorFormulaEntered;
+      return;
+    }
+    m_value = NumberConverter::toString(st.top());
 }
 
 const Cell::Type ExpressionCell::getType() const
@@ -248,6 +277,33 @@ const std::string ExpressionCell::getValue() const
     return m_value;
 }
 
+std::vector<std::shared_ptr<Cell>> ExpressionCell::getReferences() const
+{
+    std::vector<std::shared_ptr<Cell>> refs;
+    if (m_type != REFERANCE) {
+      return refs;
+    }
+    std::string data = m_data;
+    std::transform(begin(data), end(data), begin(data), [](unsigned char c){ return std::toupper(c); });
+    for (const auto& elem : tokenize(data)) {
+      std::shared_ptr<Cell> cell;
+      // calculate() stops at the first invalid token as well
+      if (!resolveToken(elem, cell)) {
+        break;
+      }
+      if (cell) {
+        refs.push_back(cell);
+      }
+    }
+    return refs;
+}
+
+void ExpressionCell::setError(const std::string& error)
+{
+    m_value = error;
+    m_isCalculated = true;
+}
+
 bool ExpressionCell::isParenthesis(const std::string& token)
 {
     return token == "(" || token == ")";
@@ -325,155 +381,143 @@ const std::pair<char, int> ExpressionCell::getCellPosition() const
     return m_cellPosition;
 }
 
-std::shared_ptr<Cell> ExpressionCell::getCell(char l, int row) const
-{
-    return m_cells.find(l)->second[row - 1];
-}
-
-std::vector<std::string> ExpressionCell::simpleExpressionTokenize(std::string& data)
+std::vector<std::string> ExpressionCell::tokenize(const std::string& data)
 {
+    // data starts with '=', spaces are dropped
     std::vector<std::string> tokens;
     std::string str = "";
-    data.erase(0, 1);
-    for (auto i : data) {
-      const std::string token(1, i);
+    for (size_t i = 1; i < data.size(); ++i) {
+      const std::string token(1, data[i]);
 
       if (isOperator(token) || isParenthesis(token)) {
           if (!str.empty()) {
-            if ((m_type == EXPRESSION) && !isDataNumber(str)) {
-              m_value = errorExpressionEvaluation;
-              m_isCalculated = true;
-              return tokens;
-            }
             tokens.push_back(str);
           }
           str = "";
           tokens.push_back(token);
       } else {
-          if (!token.empty() && token != " ") {
+          if (token != " ") {
               str.append(token);
           }
       }
     }
-    if (!str.empty() && str != " ") {
+    if (!str.empty()) {
       tokens.push_back(str);
     }
     return tokens;
 }
 
-std::vector<std::string> ExpressionCell::referanceExpressionTokenize(std::pair<char, int> pos, std::string& data)
+bool ExpressionCell::resolveToken(std::string token, std::shared_ptr<Cell>& cell) const
 {
-    std::vector<std::string> resultTokens;
-    if (isDataNumber(data)) {
-      m_refBackup.clear();
-      resultTokens.push_back(data);
-      return resultTokens;
+    // false for an invalid token, cell stays null for numbers, operators
+    // and parentheses
+    cell.reset();
+
+    // SHEET!A1 is a cell of another sheet of the workbook, the unnamed
+    // sheet of a single file calculation cannot be referred to
+    const mSpreadsheet* cells = &m_cells;
+    const size_t sheetEnd = token.find('!');
+    if (sheetEnd != std::string::npos) {
+      if (sheetEnd == 0) {
+        return false;
+      }
+      auto sheet = m_workbook.find(token.substr(0, sheetEnd));
+      token.erase(0, sheetEnd + 1);
+      if (sheet == m_workbook.end() || !isDataCellReferance(token)) {
+        return false;
+      }
+      cells = &sheet->second;
+    }
+    if (!isDataCellReferance(token) && !isOperator(token) && !isParenthesis(token) && !isDataNumber(token)) {
+      return false;
     }
-    if (isDataError(data)) {
-      m_value = data;
-      m_isCalculated = true;
-      m_refBackup.clear();
-      resultTokens.push_back(data);
-      return resultTokens;
+    // check if token is in map
+    auto it = cells->find(token[0]);
+    if (it == cells->end()) {
+      return isDataNumber(token) || isOperator(token) || isParenthesis(token);
     }
+    int row = 0;
+    NumberConverter::parse(token.data() + 1, token.data() + token.size(), row);
+    if (row > (int)it->second.size()) {
+      return false;
+    }
+    cell = it->second[row - 1];
+    return true;
+}
+
+std::vector<std::string> ExpressionCell::simpleExpressionTokenize(const std::string& data)
+{
+    std::vector<std::string> tokens = tokenize(data);
+    if (m_type == EXPRESSION) {
+      for (const auto& token : tokens) {
+        if (!isOperator(token) && !isParenthesis(token) && !isDataNumber(token)) {
+          m_value = errorExpressionEvaluation;
+          m_isCalculated = true;
+          break;
+        }
+      }
+    }
+    return tokens;
+}
+
+std::vector<std::string> ExpressionCell::referanceExpressionTokenize(const std::string& formula)
+{
+    std::vector<std::string> resultTokens;
+    std::string data = formula;
     std::transform(begin(data), end(data), begin(data), [](unsigned char c){ return std::toupper(c); });
 
-    auto tokens = simpleExpressionTokenize(data);
+    auto tokens = tokenize(data);
 
-    for (auto elem : tokens) {
-      if (!isDataCellReferance(elem) && !isOperator(elem) && !isParenthesis(elem) && !isDataNumber(elem)) {
+    for (const auto& elem : tokens) {
+      std::shared_ptr<Cell> tmpCell;
+      if (!resolveToken(elem, tmpCell)) {
         m_value = errorExpressionEvaluation;
         resultTokens.clear();
         resultTokens.push_back(errorExpressionEvaluation);
         m_isCalculated = true;
         break;
       }
-      // check if elem is in map
-      auto it = m_cells.find(elem[0]);
-      if (it != m_cells.end()) {
-        std::string sRow = elem;
-        int row = std::stoi(sRow.erase(0, 1));
-        if (row > it->second.size()) {
-          m_value = errorExpressionEvaluation;
-          resultTokens.clear();
-          resultTokens.push_back(errorExpressionEvaluation);
-          m_isCalculated = true;
-          break;
-        }
-        std::shared_ptr<Cell> tmpCell = getCell(elem[0], row);
-        std::string str = tmpCell->getValue();
-
-        // Calculated and value is error
-        if (isDataError(str)) {
-         m_value = str;
-         m_isCalculated = true;
-         resultTokens.clear();
-         resultTokens.push_back(data);
-         break;
-       }
-
-       // Type is number
-       else if (tmpCell->getType() == NUMBER) {
-         resultTokens.push_back(str);
-       }
-
-       // Type is text
-       else if (tmpCell->getType() == TEXT) {
-         m_value = errorExpressionEvaluation;
-         resultTokens.clear();
-         resultTokens.push_back(errorExpressionEvaluation);
-         m_isCalculated = true;
-         break;
-       }
-
-       // Type is simple expression
-       else if (tmpCell->getType() == EXPRESSION) {
-         tmpCell->calculate();
-         if (isDataError(tmpCell->getValue())) {
-           m_value = tmpCell->getValue();
-           m_isCalculated = true;
-           resultTokens.clear();
-           resultTokens.push_back(tmpCell->getValue());
-           break;
-         }
-         resultTokens.push_back(tmpCell->getValue());
-       }
-
-       // Type is empty = '0'
-       else if (tmpCell->getType() == EMPTY) {
-         resultTokens.push_back("0");
-       }
-
-       else {
-         auto it = m_refBackup.find(tmpCell);
-         if (it != m_refBackup.end()) {
-           m_value = errorReferenceCycling;
-           m_isCalculated = true;
-           m_refBackup.clear();
-           resultTokens.clear();
-           resultTokens.push_back(errorReferenceCycling);
-           return resultTokens;
-         } else {
-           m_refBackup.insert(tmpCell);
-         }
-
-         std::shared_ptr<ExpressionCell> exprtmp = std::dynamic_pointer_cast<ExpressionCell>(tmpCell);
-         std::vector<std::string> tmp = referanceExpressionTokenize(exprtmp->getCellPosition(), str);
-         resultTokens.assign(begin(tmp), end(tmp));
-       }
-      } else {
-        if (isDataNumber(elem) || isOperator(elem) || isParenthesis(elem)) {
-          resultTokens.push_back(elem);
-        }
-        else {
-          m_value = errorExpressionEvaluation;
-          resultTokens.clear();
-          resultTokens.push_back(errorExpressionEvaluation);
-          m_isCalculated = true;
-          break;
-        }
+      if (!tmpCell) {
+        resultTokens.push_back(elem);
+        continue;
+      }
+      // every cell type calculates idempotently, so the value read here
+      // does not depend on the order the cells are calculated in
+      tmpCell->calculate();
+      std::string str = tmpCell->getValue();
+
+      // Calculated and value is error
+      if (isDataError(str)) {
+        m_value = str;
+        m_isCalculated = true;
+        resultTokens.clear();
+        resultTokens.push_back(data);
+        break;
+      }
+
+      // Type is number, a calculated "0" has no digits left
+      else if (tmpCell->getType() == NUMBER) {
+        resultTokens.push_back(str.empty() ? "0" : str);
+      }
+
+      // Type is text
+      else if (tmpCell->getType() == TEXT) {
+        m_value = errorExpressionEvaluation;
+        resultTokens.clear();
+        resultTokens.push_back(errorExpressionEvaluation);
+        m_isCalculated = true;
+        break;
+      }
+
+      // Type is empty = '0'
+      else if (tmpCell->getType() == EMPTY) {
+        resultTokens.push_back("0");
+      }
+
+      // Type is expression, cycles are already marked before calculation
+      else {
+        resultTokens.push_back(str);
       }
     }
-    m_refBackup.clear();
     return resultTokens;
 }
@@ -4,7 +4,7 @@
 #include <map>
 #include <vector>
 #include <memory>
-#include <set>
+#include <string>
 
 
 /* ----------------------- Base Cell-----------------------*/
@@ -12,6 +12,8 @@ class Cell
 {
 public:
   typedef std::map<char, std::vector<std::shared_ptr<Cell>>> mSpreadsheet;
+  // sheets by upper case name, formulas refer to them as SHEET!A1
+  typedef std::map<std::string, mSpreadsheet> mWorkbook;
 
   enum Type
   {
@@ -26,6 +28,7 @@ public:
   static const std::string errorExpressionEvaluation;
   static const std::string errorReferenceCycling;
   static const std::string errorFormulaEntered;
+  static const std::string errorDivisionByZero;
   static bool isDataError(const std::string& cellData);
 
   static bool isDataEmpty(const std::string& cellData);
@@ -41,7 +44,7 @@ public:
   virtual void calculate() = 0;
   virtual const Type getType() const = 0;
   virtual const std::string getValue() const = 0;
-  static std::shared_ptr<Cell> createCell(const std::string&, const mSpreadsheet&, std::pair<char, int>);
+  static std::shared_ptr<Cell> createCell(const std::string&, const mSpreadsheet&, const mWorkbook&, std::pair<char, int>);
 };
 
 /* ----------------------- EmptyCell -----------------------*/
@@ -68,6 +71,7 @@ public:
   virtual const std::string getValue() const;
 private:
   std::string m_value;
+  const std::string m_data;
   const Type m_type;
 };
 
@@ -82,6 +86,7 @@ public:
   virtual const std::string getValue() const;
 private:
   std::string m_value;
+  const std::string m_data;
   const Type m_type;
 };
 
@@ -89,21 +94,25 @@ private:
 class ExpressionCell : public Cell
 {
 public:
-  ExpressionCell(const std::string& cellData, const mSpreadsheet& cells, Type type, std::pair<char, int>);
+  ExpressionCell(const std::string& cellData, const mSpreadsheet& cells, const mWorkbook& workbook, Type type, std::pair<char, int>);
   ~ExpressionCell();
   virtual void calculate();
   virtual const Type getType() const;
   virtual const std::string getValue() const;
+  // cells the formula refers to, resolved the same way as in calculate()
+  std::vector<std::shared_ptr<Cell>> getReferences() const;
+  void setError(const std::string& error);
 
 private:
-  bool isParenthesis(const std::string& token);
-  bool isOperator(const std::string& token);
+  static bool isParenthesis(const std::string& token);
+  static bool isOperator(const std::string& token);
   bool isMatchParentheses(const std::vector<std::string>&);
 
   const std::pair<char, int> getCellPosition() const;
-  std::shared_ptr<Cell> getCell(char l, int row) const;
-  std::vector<std::string> simpleExpressionTokenize(std::string& data);
-  std::vector<std::string> referanceExpressionTokenize(std::pair<char, int> pos, std::string& data);
+  static std::vector<std::string> tokenize(const std::string& data);
+  bool resolveToken(std::string token, std::shared_ptr<Cell>& cell) const;
+  std::vector<std::string> simpleExpressionTokenize(const std::string& data);
+  std::vector<std::string> referanceExpressionTokenize(const std::string& formula);
 
 private:
   std::string m_value;
@@ -111,9 +120,9 @@ private:
   const Type m_type;
   bool m_isCalculated;
   const mSpreadsheet& m_cells;
+  const mWorkbook& m_workbook;
   std::pair<char, int> m_cellPosition;
   std::vector<std::string> m_tokens;
-  std::set<std::shared_ptr<Cell>> m_refBackup;
 };
 
 
@@ -0,0 +1,37 @@
+#include <charconv>
+
+#include "./NumberConverter.h"
+
+/* ----------------------- NumberConverter -----------------------*/
+bool NumberConverter::parse(const char* first, const char* last, int& value)
+{
+    // std::from_chars does not accept a leading '+', std::stoi did
+    if (first != last && *first == '+') {
+      ++first;
+      if (first != last && *first == '-') {
+        return false;
+      }
+    }
+    const auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+bool NumberConverter::parse(const std::string& data, int& value)
+{
+    return parse(data.data(), data.data() + data.size(), value);
+}
+
+void NumberConverter::append(std::string& out, int value)
+{
+    // enough for the sign and all digits of a 32/64 bit int
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+std::string NumberConverter::toString(int value)
+{
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, result.ptr);
+}
@@ -0,0 +1,18 @@
+#ifndef NUMBERCONVERTER_H
+#define NUMBERCONVERTER_H
+
+#include <string>
+
+/* ----------------------- NumberConverter -----------------------*/
+// Locale independent integer parsing/formatting shared by the reader,
+// the evaluator and the writer (built on std::from_chars/std::to_chars).
+class NumberConverter
+{
+public:
+  static bool parse(const char* first, const char* last, int& value);
+  static bool parse(const std::string& data, int& value);
+  static void append(std::string& out, int value);
+  static std::string toString(int value);
+};
+
+#endif // NUMBERCONVERTER_H
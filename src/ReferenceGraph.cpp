@@ -0,0 +1,180 @@
+#include <algorithm>
+
+#include <numeric>
+
+#include "./Cell.h"
+#include "./ReferenceGraph.h"
+#include "./ThreadPool.h"
+
+/* ----------------------- ReferenceGraph -----------------------*/
+ReferenceGraph::ReferenceGraph(const mWorkbook& workbook)
+    : m_workbook(workbook)
+{}
+
+ReferenceGraph::~ReferenceGraph()
+{}
+
+void ReferenceGraph::calculate(ThreadPool* pool)
+{
+    build();
+    findComponents();
+    const auto groups = groupComponentsBySheets();
+    if (pool == nullptr || groups.size() < 2) {
+      for (const auto& group : groups) {
+        calculateComponents(group);
+      }
+      return;
+    }
+    // groups share no cells, each one is calculated by a single task
+    for (const auto& group : groups) {
+      pool->submit([this, &group]{ calculateComponents(group); });
+    }
+    pool->wait();
+}
+
+std::vector<std::vector<int>> ReferenceGraph::groupComponentsBySheets() const
+{
+    // union-find over the sheets linked by a reference
+    std::vector<int> parent(m_workbook.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&parent](int x) {
+      while (parent[x] != x) {
+        x = parent[x] = parent[parent[x]];
+      }
+      return x;
+    };
+    for (int v = 0; v < (int)m_nodes.size(); ++v) {
+      for (int w : m_edges[v]) {
+        parent[find(m_nodeSheets[v])] = find(m_nodeSheets[w]);
+      }
+    }
+
+    // keeps the dependency order of the components inside every group
+    std::map<int, std::vector<int>> groups;
+    for (int c = 0; c < (int)m_components.size(); ++c) {
+      groups[find(m_nodeSheets[m_components[c][0]])].push_back(c);
+    }
+    std::vector<std::vector<int>> result;
+    for (auto& it : groups) {
+      result.push_back(std::move(it.second));
+    }
+    return result;
+}
+
+void ReferenceGraph::calculateComponents(const std::vector<int>& components) const
+{
+    for (int c : components) {
+      const auto& component = m_components[c];
+      if (isCycle(component)) {
+        for (int v : component) {
+          std::dynamic_pointer_cast<ExpressionCell>(m_nodes[v])->setError(Cell::errorReferenceCycling);
+        }
+        continue;
+      }
+      for (int v : component) {
+        m_nodes[v]->calculate();
+      }
+    }
+}
+
+void ReferenceGraph::build()
+{
+    m_nodeIndexes.clear();
+    m_nodes.clear();
+    m_nodeSheets.clear();
+    size_t size = 0;
+    for (const auto& it : m_workbook) {
+      for (const auto& column : it.second) {
+        size += column.second.size();
+      }
+    }
+    m_nodeIndexes.reserve(size);
+    m_nodes.reserve(size);
+    int sheet = 0;
+    for (const auto& it : m_workbook) {
+      for (const auto& column : it.second) {
+        for (const auto& cell : column.second) {
+          m_nodeIndexes[cell.get()] = (int)m_nodes.size();
+          m_nodes.push_back(cell);
+        }
+      }
+      m_nodeSheets.resize(m_nodes.size(), sheet);
+      ++sheet;
+    }
+
+    m_edges.assign(m_nodes.size(), std::vector<int>());
+    for (int v = 0; v < (int)m_nodes.size(); ++v) {
+      if (m_nodes[v]->getType() != Cell::REFERANCE) {
+        continue;
+      }
+      auto cell = std::dynamic_pointer_cast<ExpressionCell>(m_nodes[v]);
+      for (const auto& ref : cell->getReferences()) {
+        m_edges[v].push_back(m_nodeIndexes.find(ref.get())->second);
+      }
+    }
+}
+
+void ReferenceGraph::findComponents()
+{
+    const int n = (int)m_nodes.size();
+    std::vector<int> index(n, -1);
+    std::vector<int> lowlink(n, 0);
+    std::vector<bool> onStack(n, false);
+    std::vector<int> stack;
+    // explicit call stack: (node, next edge), long reference chains
+    // must not overflow the native one
+    std::vector<std::pair<int, size_t>> callStack;
+    int counter = 0;
+
+    m_components.clear();
+    auto visit = [&](int v) {
+      index[v] = lowlink[v] = counter++;
+      stack.push_back(v);
+      onStack[v] = true;
+      callStack.push_back(std::make_pair(v, 0));
+    };
+
+    for (int root = 0; root < n; ++root) {
+      if (index[root] != -1) {
+        continue;
+      }
+      visit(root);
+      while (!callStack.empty()) {
+        const int v = callStack.back().first;
+        if (callStack.back().second < m_edges[v].size()) {
+          const int w = m_edges[v][callStack.back().second++];
+          if (index[w] == -1) {
+            visit(w);
+          } else if (onStack[w]) {
+            lowlink[v] = std::min(lowlink[v], index[w]);
+          }
+          continue;
+        }
+        callStack.pop_back();
+        if (!callStack.empty()) {
+          const int u = callStack.back().first;
+          lowlink[u] = std::min(lowlink[u], lowlink[v]);
+        }
+        if (lowlink[v] == index[v]) {
+          std::vector<int> component;
+          int w = -1;
+          do {
+            w = stack.back();
+            stack.pop_back();
+            onStack[w] = false;
+            component.push_back(w);
+          } while (w != v);
+          m_components.push_back(component);
+        }
+      }
+    }
+}
+
+bool ReferenceGraph::isCycle(const std::vector<int>& component) const
+{
+    if (component.size() > 1) {
+      return true;
+    }
+    const auto& edges = m_edges[component[0]];
+    return std::find(edges.begin(), edges.end(), component[0]) != edges.end();
+}
@@ -0,0 +1,47 @@
+#ifndef REFERENCEGRAPH_H
+#define REFERENCEGRAPH_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Cell;
+class ThreadPool;
+
+/* ----------------------- ReferenceGraph -----------------------*/
+// Dependency graph of all sheets of the workbook. Strongly connected
+// components are found in one linear pass (Tarjan); cells of a cycle are
+// marked as circular and every other cell is calculated after the cells
+// it references, so error values reach their dependents in a single
+// forward sweep. Sheets not linked by references are calculated
+// concurrently.
+class ReferenceGraph
+{
+  typedef std::map<char, std::vector<std::shared_ptr<Cell>>> mSpreadsheet;
+  typedef std::map<std::string, mSpreadsheet> mWorkbook;
+public:
+  explicit ReferenceGraph(const mWorkbook& workbook);
+  ~ReferenceGraph();
+  // pool may be null, then everything is calculated on the calling thread
+  void calculate(ThreadPool* pool);
+
+private:
+  void build();
+  void findComponents();
+  std::vector<std::vector<int>> groupComponentsBySheets() const;
+  void calculateComponents(const std::vector<int>& components) const;
+  bool isCycle(const std::vector<int>& component) const;
+
+private:
+  const mWorkbook& m_workbook;
+  std::unordered_map<const Cell*, int> m_nodeIndexes;
+  std::vector<std::shared_ptr<Cell>> m_nodes;
+  std::vector<int> m_nodeSheets;
+  std::vector<std::vector<int>> m_edges;
+  // in reverse topological order: referenced cells come first
+  std::vector<std::vector<int>> m_components;
+};
+
+#endif // REFERENCEGRAPH_H
@@ -1,35 +1,113 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <regex>
+#include <set>
+#include <thread>
 
 #include "./Cell.h"
+#include "./NumberConverter.h"
+#include "./ReferenceGraph.h"
 #include "./SpreadsheetCalculator.h"
+#include "./ThreadPool.h"
+
+SpreadsheetCalculator::SpreadsheetCalculator()
+      : m_engine(GRAPH)
+      , m_threadCount(0)
+{}
 
 SpreadsheetCalculator::SpreadsheetCalculator(const char* inputFilename, const char* outputFilename)
-      : m_inputFilename(inputFilename)
-      , m_outputFilename(outputFilename)
+      : m_engine(GRAPH)
+      , m_threadCount(0)
 {
-  m_outputSheet = std::vector<std::string>(m_rows + 1, "");
+  // the single sheet has no name, so no formula can refer to it as Name!A1
+  insertSheet("", inputFilename, outputFilename);
 }
 
 SpreadsheetCalculator::~SpreadsheetCalculator()
 {}
 
+void SpreadsheetCalculator::addSheet(const std::string& name, const char* inputFilename, const char* outputFilename)
+{
+  // formulas are upper cased before they are tokenized
+  std::string key = name;
+  std::transform(begin(key), end(key), begin(key), [](unsigned char c){ return std::toupper(c); });
+  if (key.empty()
+    || !std::all_of(begin(key), end(key), [](unsigned char c){ return std::isalnum(c) || c == '_'; }))
+  {
+    throw std::runtime_error("Err: Invalid sheet name!");
+  }
+  if (m_workbook.find(key) != m_workbook.end()) {
+    throw std::runtime_error("Err: Duplicate sheet name!");
+  }
+  insertSheet(key, inputFilename, outputFilename);
+}
+
+void SpreadsheetCalculator::insertSheet(const std::string& key, const char* inputFilename, const char* outputFilename)
+{
+  Sheet sheet;
+  sheet.name = key;
+  sheet.inputFilename = inputFilename;
+  sheet.outputFilename = outputFilename;
+  sheet.rows = 0;
+  sheet.columns = 0;
+  sheet.cells = &m_workbook[key];
+  m_sheets.push_back(sheet);
+}
+
+void SpreadsheetCalculator::setThreadCount(unsigned int threads)
+{
+  m_threadCount = threads;
+  m_pool.reset();
+}
+
+void SpreadsheetCalculator::setEngine(Engine engine)
+{
+  m_engine = engine;
+}
+
+SpreadsheetCalculator::Sheet& SpreadsheetCalculator::getSheet(const std::string& name)
+{
+  std::string key = name;
+  std::transform(begin(key), end(key), begin(key), [](unsigned char c){ return std::toupper(c); });
+  for (auto& sheet : m_sheets) {
+    if (sheet.name == key) {
+      return sheet;
+    }
+  }
+  throw std::runtime_error("Err: Unknown sheet name!");
+}
+
 void SpreadsheetCalculator::readDataFromInputFile()
+{
+  for (auto& sheet : m_sheets) {
+    readSheet(sheet);
+  }
+}
+
+void SpreadsheetCalculator::readSheet(Sheet& sheet)
 {
   std::vector<std::vector<std::string>> inputSheet;
   std::ifstream file;
   std::string str;
   try {
-    file.open(m_inputFilename);
+    file.open(sheet.inputFilename);
+    if (!file.is_open()) {
+      throw std::runtime_error("Err: Cannot open input file!");
+    }
     bool isFileFirstLine = true;
-    std::regex tReg("\\t");
     while (std::getline(file, str)) {
-      str.erase(str.length() - 1);
-      auto const vec = std::vector<std::string>(
-        std::sregex_token_iterator{begin(str), end(str), tReg, -1},
-        std::sregex_token_iterator{});
+      if (!str.empty()) {
+        str.erase(str.length() - 1);
+      }
+      // split on every tab, "5\t" is a row of two cells with an empty last one
+      std::vector<std::string> vec;
+      size_t pos = 0;
+      for (size_t tab = str.find('\t'); tab != std::string::npos; tab = str.find('\t', pos)) {
+        vec.push_back(str.substr(pos, tab - pos));
+        pos = tab + 1;
+      }
+      vec.push_back(str.substr(pos));
 
       // validation input data format
       if (isFileFirstLine) {
@@ -39,31 +117,44 @@ void SpreadsheetCalculator::readDataFromInputFile()
         {
             throw std::runtime_error("Err: Invalid file content!");
         }
-        m_rows = std::stoi(vec[0]);
-        m_columns = std::stoi(vec[1]);
+        if (!NumberConverter::parse(vec[0], sheet.rows)
+          || !NumberConverter::parse(vec[1], sheet.columns))
+        {
+            throw std::runtime_error("Err: Invalid file content!");
+        }
         isFileFirstLine = false;
       } else {
-        if (vec.size() != m_columns) {
+        if ((int)vec.size() != sheet.columns) {
           throw std::runtime_error("Err: Invalid file content!");
         }
       }
       inputSheet.push_back(vec);
     }
     file.close();
-  } catch (std::ifstream::failure e) {
+  } catch (const std::ifstream::failure& e) {
     std::cerr << "Err: Exception opening/reading/closing input file\n";
   }
 
-  // input data in to std::map<char, std::vector<std::shared_ptr<Cell>>> m_cells
+  // the header line with the sheet size is required
+  if (inputSheet.empty()) {
+    throw std::runtime_error("Err: Invalid file content!");
+  }
+
+  // one output line per input line (header + data rows)
+  sheet.outputSheet = std::vector<std::string>(inputSheet.size(), "");
+
+  // input data in to std::map<char, std::vector<std::shared_ptr<Cell>>> sheet.cells
+  mSpreadsheet& cells = *sheet.cells;
+  cells.clear();
   {
   int i = 0;
   char l = 'A';
   std::vector<std::shared_ptr<Cell>> vCell;
-  while(i < m_columns) {
+  while(i < sheet.columns) {
     for (int j = 1; j < (int)inputSheet.size(); ++j) {
-      vCell.push_back(Cell::createCell(inputSheet[j][i], m_cells, std::make_pair(l, j)));
+      vCell.push_back(Cell::createCell(inputSheet[j][i], cells, m_workbook, std::make_pair(l, j)));
     }
-    m_cells[l] = vCell;
+    cells[l] = vCell;
     vCell.clear();
     ++l;
     ++i;
@@ -73,33 +164,220 @@ void SpreadsheetCalculator::readDataFromInputFile()
 
 void SpreadsheetCalculator::calculate()
 {
-  m_outputSheet[0] += "  ";
-  for (auto it : m_cells) {
-    m_outputSheet[0] += (it.first + std::string("\t"));
+  if (m_engine == REFERENCE) {
+    calculateRecursively();
+    return;
+  }
+  // one shared pool, only needed when there are sheets to run side by side
+  if (m_sheets.size() > 1 && m_threadCount != 1 && !m_pool) {
+    const unsigned int threads = m_threadCount != 0 ? m_threadCount : std::thread::hardware_concurrency();
+    m_pool.reset(new ThreadPool(std::min<unsigned int>(threads, m_sheets.size())));
+  }
+  ReferenceGraph graph(m_workbook);
+  graph.calculate(m_pool.get());
+}
+
+void SpreadsheetCalculator::calculateRecursively()
+{
+  // a cell is circular when it can reach itself through its references
+  for (const auto& sheet : m_workbook) {
+    for (const auto& column : sheet.second) {
+      for (const auto& cell : column.second) {
+        if (cell->getType() != Cell::REFERANCE) {
+          continue;
+        }
+        auto expression = std::dynamic_pointer_cast<ExpressionCell>(cell);
+        std::set<const Cell*> visited;
+        std::vector<std::shared_ptr<Cell>> stack = expression->getReferences();
+        bool isCircular = false;
+        while (!stack.empty() && !isCircular) {
+          const std::shared_ptr<Cell> ref = stack.back();
+          stack.pop_back();
+          isCircular = ref == cell;
+          if (ref->getType() != Cell::REFERANCE || !visited.insert(ref.get()).second) {
+            continue;
+          }
+          const auto refs = std::dynamic_pointer_cast<ExpressionCell>(ref)->getReferences();
+          stack.insert(stack.end(), refs.begin(), refs.end());
+        }
+        if (isCircular) {
+          expression->setError(Cell::errorReferenceCycling);
+        }
+      }
+    }
+  }
+
+  // referenced formulas are calculated by the cells that refer to them
+  for (const auto& sheet : m_workbook) {
+    for (const auto& column : sheet.second) {
+      for (const auto& cell : column.second) {
+        cell->calculate();
+      }
+    }
+  }
+}
+
+void SpreadsheetCalculator::formatSheet(Sheet& sheet)
+{
+  std::vector<std::string>& outputSheet = sheet.outputSheet;
+  outputSheet.assign(outputSheet.size(), "");
+  outputSheet[0] += "  ";
+  for (auto it : *sheet.cells) {
+    outputSheet[0] += (it.first + std::string("\t"));
     int j = 1;
     for (auto cell : it.second) {
       std::shared_ptr<Cell> tmp = cell;
-      tmp->calculate();
-      if (m_outputSheet[j].empty()) {
-        m_outputSheet[j] = std::to_string(j) + ' ';
+      if (outputSheet[j].empty()) {
+        NumberConverter::append(outputSheet[j], j);
+        outputSheet[j] += ' ';
       }
-      m_outputSheet[j] = (m_outputSheet[j] + tmp->getValue() + std::string("\t"));
+      outputSheet[j] = (outputSheet[j] + tmp->getValue() + std::string("\t"));
       ++j;
     }
   }
 }
 
-void SpreadsheetCalculator::writeCalculatedDataToOutputFile()
+void SpreadsheetCalculator::takeSnapshot(Sheet& sheet)
+{
+  sheet.snapshot.clear();
+  for (const auto& it : *sheet.cells) {
+    int j = 1;
+    for (const auto& cell : it.second) {
+      const std::string value = cell->getValue();
+      if (!value.empty()) {
+        sheet.snapshot[std::make_pair(it.first, j)] = value;
+      }
+      ++j;
+    }
+  }
+}
+
+void SpreadsheetCalculator::readSnapshotFromFile(const char* filename)
+{
+  readSnapshot(m_sheets.front(), filename);
+}
+
+void SpreadsheetCalculator::readSnapshotFromFile(const std::string& sheetName, const char* filename)
+{
+  readSnapshot(getSheet(sheetName), filename);
+}
+
+void SpreadsheetCalculator::readSnapshot(Sheet& sheet, const char* filename)
+{
+  // a sheet previously written by writeCalculatedDataToOutputFile
+  sheet.snapshot.clear();
+  std::ifstream file;
+  std::string str;
+  try {
+    file.open(filename);
+    if (!file.is_open()) {
+      throw std::runtime_error("Err: Cannot open snapshot file!");
+    }
+    std::vector<char> columns;
+    bool isFileFirstLine = true;
+    while (std::getline(file, str)) {
+      size_t pos = 0;
+      int row = 0;
+      if (isFileFirstLine) {
+        pos = 2;
+      } else {
+        const size_t space = str.find(' ');
+        if (space == std::string::npos
+          || !NumberConverter::parse(str.data(), str.data() + space, row))
+        {
+          throw std::runtime_error("Err: Invalid snapshot file content!");
+        }
+        pos = space + 1;
+      }
+      for (size_t i = 0; pos < str.size(); ++i) {
+        size_t tab = str.find('\t', pos);
+        if (tab == std::string::npos) {
+          tab = str.size();
+        }
+        if (isFileFirstLine) {
+          columns.push_back(str[pos]);
+        } else if (i < columns.size() && tab != pos) {
+          sheet.snapshot[std::make_pair(columns[i], row)] = str.substr(pos, tab - pos);
+        }
+        pos = tab + 1;
+      }
+      isFileFirstLine = false;
+    }
+    file.close();
+  } catch (const std::ifstream::failure& e) {
+    std::cerr << "Err: Exception opening/reading/closing snapshot file\n";
+  }
+}
+
+void SpreadsheetCalculator::writeChangesToOutputFile()
 {
   calculate();
+  for (auto& sheet : m_sheets) {
+    writeChanges(sheet);
+  }
+}
+
+void SpreadsheetCalculator::writeChanges(Sheet& sheet)
+{
+  mSnapshot previous;
+  previous.swap(sheet.snapshot);
+  takeSnapshot(sheet);
+
+  // walk both ordered snapshots at once, a missing cell has value ""
+  std::string changes;
+  auto oldIt = previous.begin();
+  auto newIt = sheet.snapshot.begin();
+  const std::string empty;
+  while (oldIt != previous.end() || newIt != sheet.snapshot.end()) {
+    std::pair<char, int> pos;
+    const std::string* oldValue = &empty;
+    const std::string* newValue = &empty;
+    if (newIt == sheet.snapshot.end()
+      || (oldIt != previous.end() && oldIt->first < newIt->first))
+    {
+      pos = oldIt->first;
+      oldValue = &(oldIt++)->second;
+    } else if (oldIt == previous.end() || newIt->first < oldIt->first) {
+      pos = newIt->first;
+      newValue = &(newIt++)->second;
+    } else {
+      pos = newIt->first;
+      oldValue = &(oldIt++)->second;
+      newValue = &(newIt++)->second;
+    }
+    if (*oldValue == *newValue) {
+      continue;
+    }
+    changes += pos.first;
+    NumberConverter::append(changes, pos.second);
+    changes += '\t' + *oldValue + '\t' + *newValue + '\n';
+  }
+
   std::ofstream file;
   try {
-    file.open(m_outputFilename);
-    for (const auto& line : m_outputSheet) {
-      file << line + '\n';
-    }
+    file.open(sheet.outputFilename);
+    file << changes;
     file.close();
-  } catch (const std::ios_base::failure e) {
+  } catch (const std::ios_base::failure& e) {
     std::cerr << "Err: Exception opening/writing/closing output file\n";
   }
 }
+
+void SpreadsheetCalculator::writeCalculatedDataToOutputFile()
+{
+  calculate();
+  for (auto& sheet : m_sheets) {
+    formatSheet(sheet);
+    takeSnapshot(sheet);
+    std::ofstream file;
+    try {
+      file.open(sheet.outputFilename);
+      for (const auto& line : sheet.outputSheet) {
+        file << line + '\n';
+      }
+      file.close();
+    } catch (const std::ios_base::failure& e) {
+      std::cerr << "Err: Exception opening/writing/closing output file\n";
+    }
+  }
+}
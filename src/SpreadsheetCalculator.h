@@ -3,29 +3,70 @@
 
 #include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 class Cell;
+class ThreadPool;
 
 class SpreadsheetCalculator
 {
   typedef std::map<char, std::vector<std::shared_ptr<Cell>>> mSpreadsheet;
+  typedef std::map<std::string, mSpreadsheet> mWorkbook;
+  typedef std::map<std::pair<char, int>, std::string> mSnapshot;
+
+  struct Sheet
+  {
+    std::string name;
+    const char* inputFilename;
+    const char* outputFilename;
+    int rows;
+    int columns;
+    mSpreadsheet* cells;
+    std::vector<std::string> outputSheet;
+    mSnapshot snapshot;
+  };
 public:
+  enum Engine
+  {
+    // recursive evaluation in sheet order, cycles found by a walk from every cell;
+    // slow, kept as the reference the other engines are compared against
+    REFERENCE,
+    // ReferenceGraph: SCC pass, dependency order, independent sheets in parallel
+    GRAPH
+  };
+
+  SpreadsheetCalculator();
   SpreadsheetCalculator(const char* inputFilename, const char* outputFilename);
   ~SpreadsheetCalculator();
+  // workbook of named sheets ([A-Za-z0-9_]+), formulas refer to other sheets as Name!A1
+  void addSheet(const std::string& name, const char* inputFilename, const char* outputFilename);
+  // 0 uses the hardware concurrency, 1 calculates serially on the calling thread
+  void setThreadCount(unsigned int threads);
+  void setEngine(Engine engine);
   void readDataFromInputFile();
   void writeCalculatedDataToOutputFile();
+  // delta output: (cell, old, new) for the cells changed since the last snapshot
+  void readSnapshotFromFile(const char* filename);
+  void readSnapshotFromFile(const std::string& sheetName, const char* filename);
+  void writeChangesToOutputFile();
 
 private:
+  void insertSheet(const std::string& key, const char* inputFilename, const char* outputFilename);
   void calculate();
+  void calculateRecursively();
+  void readSheet(Sheet& sheet);
+  void formatSheet(Sheet& sheet);
+  void takeSnapshot(Sheet& sheet);
+  void readSnapshot(Sheet& sheet, const char* filename);
+  void writeChanges(Sheet& sheet);
+  Sheet& getSheet(const std::string& name);
 private:
-  int m_rows;
-  int m_columns;
-  const char* m_inputFilename;
-  const char* m_outputFilename;
-  mSpreadsheet m_cells;
-
-  std::vector<std::string> m_outputSheet;
+  std::vector<Sheet> m_sheets;
+  mWorkbook m_workbook;
+  Engine m_engine;
+  unsigned int m_threadCount;
+  std::unique_ptr<ThreadPool> m_pool;
 };
 
 #endif // SPREADSHEETCALCULATOR_H
@@ -0,0 +1,64 @@
+#include "./ThreadPool.h"
+
+/* ----------------------- ThreadPool -----------------------*/
+ThreadPool::ThreadPool(unsigned int threads)
+    : m_activeTasks(0)
+    , m_isStopped(false)
+{
+    if (threads == 0) {
+      threads = 1;
+    }
+    for (unsigned int i = 0; i < threads; ++i) {
+      m_workers.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_isStopped = true;
+    }
+    m_taskAdded.notify_all();
+    for (auto& worker : m_workers) {
+      worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.push(std::move(task));
+    }
+    m_taskAdded.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_tasksFinished.wait(lock, [this]{ return m_tasks.empty() && m_activeTasks == 0; });
+}
+
+void ThreadPool::run()
+{
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_taskAdded.wait(lock, [this]{ return m_isStopped || !m_tasks.empty(); });
+        if (m_tasks.empty()) {
+          return;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop();
+        ++m_activeTasks;
+      }
+      task();
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_activeTasks;
+      }
+      m_tasksFinished.notify_all();
+    }
+}
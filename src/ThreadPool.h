@@ -0,0 +1,34 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/* ----------------------- ThreadPool -----------------------*/
+// Fixed set of workers shared by every evaluation of the workbook.
+class ThreadPool
+{
+public:
+  explicit ThreadPool(unsigned int threads);
+  ~ThreadPool();
+  void submit(std::function<void()> task);
+  void wait();
+
+private:
+  void run();
+
+private:
+  std::vector<std::thread> m_workers;
+  std::queue<std::function<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_taskAdded;
+  std::condition_variable m_tasksFinished;
+  int m_activeTasks;
+  bool m_isStopped;
+};
+
+#endif // THREADPOOL_H
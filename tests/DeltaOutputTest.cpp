@@ -0,0 +1,92 @@
+// Delta output and repeated evaluation on one SpreadsheetCalculator.
+// g++ -std=c++17 -pthread -o DeltaOutputTest tests/DeltaOutputTest.cpp src/*.cpp
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../src/SpreadsheetCalculator.h"
+
+static int failures = 0;
+
+static void expect(const char* what, const std::string& actual, const std::string& expected)
+{
+  if (actual != expected) {
+    std::cerr << what << ": output differs\n--- expected\n" << expected << "--- actual\n" << actual;
+    ++failures;
+  }
+}
+
+static std::string readFile(const std::string& filename)
+{
+  std::ifstream file(filename);
+  std::ostringstream s;
+  s << file.rdbuf();
+  return s.str();
+}
+
+int main()
+{
+  const std::filesystem::path dir = std::filesystem::temp_directory_path();
+  const std::string input = (dir / "delta.in.tsv").string();
+  const std::string output = (dir / "delta.out.tsv").string();
+  const std::string sheet =
+    "  A\tB\t\n"
+    "1 5\t6\t\n"
+    "2 x\ty\t\n";
+
+  std::ofstream(input, std::ios::binary) << "2\t2\r\n005\t=A1+1\r\n'x\t'y\r\n";
+  SpreadsheetCalculator calculator(input.c_str(), output.c_str());
+  calculator.readDataFromInputFile();
+
+  calculator.writeCalculatedDataToOutputFile();
+  expect("first evaluation", readFile(output), sheet);
+
+  // no edit: nothing changed, and a second full write is the same sheet
+  calculator.writeChangesToOutputFile();
+  expect("delta without edit", readFile(output), "");
+  calculator.writeCalculatedDataToOutputFile();
+  expect("second evaluation", readFile(output), sheet);
+
+  // edit and re-read: only the affected cells are listed
+  std::ofstream(input, std::ios::binary) << "2\t2\r\n7\t=A1+1\r\n'x\t'z\r\n";
+  calculator.readDataFromInputFile();
+  calculator.writeChangesToOutputFile();
+  expect("delta after edit", readFile(output),
+         "A1\t5\t7\n"
+         "B1\t6\t8\n"
+         "B2\ty\tz\n");
+
+  // against a sheet written by an earlier run
+  const std::string previous = (dir / "delta.previous.tsv").string();
+  std::ofstream(previous, std::ios::binary) << sheet;
+  SpreadsheetCalculator other(input.c_str(), output.c_str());
+  other.readDataFromInputFile();
+  other.readSnapshotFromFile(previous.c_str());
+  other.writeChangesToOutputFile();
+  expect("delta against file", readFile(output),
+         "A1\t5\t7\n"
+         "B1\t6\t8\n"
+         "B2\ty\tz\n");
+
+  // a snapshot file that cannot be opened is an error, not an empty sheet
+  bool isThrown = false;
+  try {
+    other.readSnapshotFromFile((dir / "delta.missing" / "previous.tsv").string().c_str());
+  } catch (const std::runtime_error& e) {
+    isThrown = true;
+  }
+  expect("missing snapshot file", isThrown ? "thrown" : "not thrown", "thrown");
+
+  std::filesystem::remove(input);
+  std::filesystem::remove(output);
+  std::filesystem::remove(previous);
+  if (failures != 0) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "DeltaOutputTest: OK\n";
+  return 0;
+}
@@ -0,0 +1,628 @@
+// Differential test: random workbooks (numbers, text, empties, simple and
+// reference expressions, cross-sheet references, cycles) are calculated by
+// every engine and the written sheets must be byte-identical to the ones of
+// the recursive reference engine. Independently of the engines' shared cell
+// code, every cell the baseline evaluator was well defined for (no formula
+// referring to a formula, no cycle, well formed formula) is also checked
+// against a small evaluator in this file. Prints the time spent in each engine.
+// g++ -std=c++17 -O2 -pthread -o DifferentialTest tests/DifferentialTest.cpp src/*.cpp
+// ./DifferentialTest [iterations=200] [seed=1] [maxRows=10]
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/SpreadsheetCalculator.h"
+
+struct Workbook
+{
+  // a single "" sheet is calculated like main does for two files
+  std::vector<std::string> names;
+  std::vector<std::vector<std::vector<std::string>>> grids;
+  std::vector<std::string> inputs;
+};
+
+struct Engine
+{
+  const char* name;
+  // calculates the workbook, fills the output files and returns the seconds spent
+  std::function<double(const Workbook&, const std::vector<std::string>&, const std::vector<std::string>&)> run;
+  double seconds;
+};
+
+/* ----------------------- generator -----------------------*/
+static std::mt19937 rng;
+
+static int uniform(int from, int to)
+{
+  return std::uniform_int_distribution<int>(from, to)(rng);
+}
+
+template <typename T>
+static const T& pick(const std::vector<T>& values)
+{
+  return values[uniform(0, (int)values.size() - 1)];
+}
+
+static std::string cellName(int column, int row)
+{
+  return std::string(1, (char)('A' + column)) + std::to_string(row);
+}
+
+static std::string randomNumber()
+{
+  static const std::vector<std::string> special = { "0", "00", "007", "-3", "+4", "-0", "2147483647" };
+  return uniform(0, 3) == 0 ? pick(special) : std::to_string(uniform(0, 1000));
+}
+
+static std::string randomOperand(const Workbook& workbook, int rows, int columns)
+{
+  switch (uniform(0, 9)) {
+    case 0:
+    case 1:
+    case 2:
+      return std::to_string(uniform(0, 50));
+    case 3:
+      // lower case reference
+      return std::string(1, (char)('a' + uniform(0, columns - 1))) + std::to_string(uniform(1, rows));
+    case 4:
+      // out of the sheet
+      return cellName(uniform(0, columns), rows + uniform(1, 3));
+    case 5: {
+      // other sheet, one that does not exist, or no sheet name at all
+      const int choice = uniform(0, 5);
+      const std::string sheet = choice == 0 ? "NOSHEET" : choice == 1 ? "" : pick(workbook.names);
+      return sheet + "!" + cellName(uniform(0, columns - 1), uniform(1, rows));
+    }
+    default:
+      return cellName(uniform(0, columns - 1), uniform(1, rows));
+  }
+}
+
+static std::string randomFormula(const std::function<std::string()>& operand)
+{
+  static const std::vector<std::string> operators = { "+", "-", "*", "/" };
+  static const std::vector<std::string> malformed = { "=", "=()", "=(1+2", "=1+2)", "=*3", "=--3", "=1/0", "=4 / (2-2)" };
+  if (uniform(0, 9) == 0) {
+    return pick(malformed);
+  }
+  std::string formula = "=";
+  const int count = uniform(1, 4);
+  for (int i = 0; i < count; ++i) {
+    if (i != 0) {
+      formula += pick(operators);
+    }
+    if (uniform(0, 5) == 0) {
+      formula += "(" + operand() + pick(operators) + operand() + ")";
+    } else {
+      formula += (uniform(0, 7) == 0 ? " " : "") + operand();
+    }
+  }
+  return formula;
+}
+
+static std::string randomCell(const Workbook& workbook, int rows, int columns)
+{
+  switch (uniform(0, 9)) {
+    case 0:
+      return "";
+    case 1:
+    case 2:
+      return randomNumber();
+    case 3:
+      return pick(std::vector<std::string>{ "'text", "'a b", "'", "plain", "'=A1" });
+    case 4:
+    case 5:
+      return randomFormula([] { return std::to_string(uniform(0, 50)); });
+    default:
+      return randomFormula([&] { return randomOperand(workbook, rows, columns); });
+  }
+}
+
+static Workbook generateWorkbook(int maxRows)
+{
+  Workbook workbook;
+  // one in four is the unnamed sheet of a two file calculation
+  if (uniform(0, 3) == 0) {
+    workbook.names.push_back("");
+  } else {
+    const int sheets = uniform(1, 3);
+    for (int s = 0; s < sheets; ++s) {
+      workbook.names.push_back("S" + std::to_string(s));
+    }
+  }
+  const int count = (int)workbook.names.size();
+  std::vector<std::vector<std::vector<std::string>>>& grids = workbook.grids;
+  for (int s = 0; s < count; ++s) {
+    const int rows = uniform(1, maxRows);
+    const int columns = uniform(1, 5);
+    std::vector<std::vector<std::string>> grid(rows, std::vector<std::string>(columns));
+    for (auto& row : grid) {
+      for (auto& cell : row) {
+        cell = randomCell(workbook, rows, columns);
+      }
+    }
+    grids.push_back(grid);
+  }
+
+  // cycles, possibly across sheets, and cells depending on them
+  const int cycles = uniform(0, 2);
+  for (int c = 0; c < cycles; ++c) {
+    std::vector<std::pair<int, std::pair<int, int>>> chain;
+    const int length = uniform(1, 4);
+    for (int i = 0; i < length; ++i) {
+      const int s = uniform(0, count - 1);
+      chain.push_back(std::make_pair(s, std::make_pair(uniform(0, (int)grids[s].size() - 1),
+                                                       uniform(0, (int)grids[s][0].size() - 1))));
+    }
+    for (int i = 0; i < length; ++i) {
+      const auto& next = chain[(i + 1) % length];
+      const std::string& name = workbook.names[next.first];
+      const std::string ref = (name.empty() ? "" : name + "!") + cellName(next.second.second, next.second.first + 1);
+      grids[chain[i].first][chain[i].second.first][chain[i].second.second] = "=" + ref + "+1";
+    }
+  }
+
+  for (const auto& grid : grids) {
+    std::string input = std::to_string(grid.size()) + "\t" + std::to_string(grid[0].size()) + "\r\n";
+    for (const auto& row : grid) {
+      for (size_t i = 0; i < row.size(); ++i) {
+        input += (i != 0 ? "\t" : "") + row[i];
+      }
+      input += "\r\n";
+    }
+    workbook.inputs.push_back(input);
+  }
+  return workbook;
+}
+
+/* ----------------------- engines -----------------------*/
+static void writeFile(const std::string& filename, const std::string& content)
+{
+  std::ofstream(filename, std::ios::binary) << content;
+}
+
+static std::string readFile(const std::string& filename)
+{
+  std::ifstream file(filename, std::ios::binary);
+  std::ostringstream s;
+  s << file.rdbuf();
+  return s.str();
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::unique_ptr<SpreadsheetCalculator> createCalculator(const Workbook& workbook,
+                                                               const std::vector<std::string>& inputs,
+                                                               const std::vector<std::string>& outputs)
+{
+  if (workbook.names[0].empty()) {
+    return std::unique_ptr<SpreadsheetCalculator>(new SpreadsheetCalculator(inputs[0].c_str(), outputs[0].c_str()));
+  }
+  std::unique_ptr<SpreadsheetCalculator> calculator(new SpreadsheetCalculator());
+  for (size_t s = 0; s < inputs.size(); ++s) {
+    calculator->addSheet(workbook.names[s], inputs[s].c_str(), outputs[s].c_str());
+  }
+  return calculator;
+}
+
+static double runEngine(SpreadsheetCalculator::Engine engine, unsigned int threads, const Workbook& workbook,
+                        const std::vector<std::string>& inputs, const std::vector<std::string>& outputs)
+{
+  const auto start = std::chrono::steady_clock::now();
+  auto calculator = createCalculator(workbook, inputs, outputs);
+  calculator->setEngine(engine);
+  calculator->setThreadCount(threads);
+  calculator->readDataFromInputFile();
+  calculator->writeCalculatedDataToOutputFile();
+  return secondsSince(start);
+}
+
+// recalculation on a calculator that already evaluated different sheets
+// (random ones); a delta right after the full write must be empty
+static double runIncremental(const Workbook& workbook, const std::vector<std::string>& inputs,
+                             const std::vector<std::string>& outputs, bool& isDeltaEmpty)
+{
+  auto calculator = createCalculator(workbook, inputs, outputs);
+  for (size_t s = 0; s < inputs.size(); ++s) {
+    writeFile(inputs[s], generateWorkbook(10).inputs[0]);
+  }
+  calculator->readDataFromInputFile();
+  calculator->writeCalculatedDataToOutputFile();
+
+  for (size_t s = 0; s < inputs.size(); ++s) {
+    writeFile(inputs[s], workbook.inputs[s]);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  calculator->readDataFromInputFile();
+  calculator->writeCalculatedDataToOutputFile();
+  const double seconds = secondsSince(start);
+
+  std::vector<std::string> sheets;
+  for (const auto& output : outputs) {
+    sheets.push_back(readFile(output));
+  }
+  calculator->writeChangesToOutputFile();
+  isDeltaEmpty = true;
+  for (size_t s = 0; s < outputs.size(); ++s) {
+    isDeltaEmpty = isDeltaEmpty && readFile(outputs[s]).empty();
+    writeFile(outputs[s], sheets[s]);
+  }
+  return seconds;
+}
+
+/* ----------------------- independent evaluator -----------------------*/
+// Written from the documented cell semantics, it shares no code with src/.
+// Operators apply left to right, parentheses first, on wrapping 32 bit ints.
+// A referenced cell is read as: empty 0, number its value, 'text #TEXT?,
+// other text #UNKNOWN_FORMAT; the first error in the formula is its value.
+// Cells it does not decide are left to the engine against engine check.
+struct Expected
+{
+  bool isKnown;
+  std::string value;
+};
+
+static bool isDigits(const std::string& s, size_t from)
+{
+  return from < s.size() && s.find_first_not_of("0123456789", from) == std::string::npos;
+}
+
+static int wrap(long long value)
+{
+  return (int)(unsigned int)(unsigned long long)value;
+}
+
+class Evaluator
+{
+public:
+  explicit Evaluator(const Workbook& workbook)
+    : m_workbook(workbook)
+  {}
+
+  Expected evaluate(int sheet, int row, int column) const
+  {
+    const std::string& data = m_workbook.grids[sheet][row][column];
+    if (data.empty()) {
+      return { true, "" };
+    }
+    if (data[0] == '=') {
+      return evaluateFormula(sheet, data);
+    }
+    if (isDigits(data, data[0] == '-' || data[0] == '+' ? 1 : 0)) {
+      // leading zeros are not written, a zero number is an empty cell
+      return { true, data.substr(std::min(data.find_first_not_of('0'), data.size())) };
+    }
+    if (data.find_first_of("+-0123456789") == 0 && data.find_first_not_of("+-0123456789") == std::string::npos) {
+      return { false, "" };
+    }
+    if (data[0] != '\'') {
+      return { true, "#UNKNOWN_FORMAT" };
+    }
+    // text looking like an error value is not decided here
+    return { data.size() < 2 || data[1] != '#', data.substr(1) };
+  }
+
+private:
+  struct Token
+  {
+    char op;  // 0 for a value
+    long long value;
+  };
+
+  struct Operand
+  {
+    enum Kind { LITERAL, CELL, OUTSIDE, UNDECIDED } kind;
+    long long value;
+    int sheet;
+    int row;
+    int column;
+  };
+
+  Operand locate(int sheet, const std::string& operand) const
+  {
+    if (isDigits(operand, 0)) {
+      const bool isInt = operand.size() <= 10 && std::stoll(operand) <= INT_MAX;
+      return { isInt ? Operand::LITERAL : Operand::UNDECIDED, isInt ? std::stoll(operand) : 0, 0, 0, 0 };
+    }
+    const size_t bang = operand.find('!');
+    std::string cell = operand;
+    if (bang != std::string::npos) {
+      // an unnamed sheet cannot be referred to
+      sheet = -1;
+      for (size_t s = 0; s < m_workbook.names.size() && bang != 0; ++s) {
+        if (m_workbook.names[s] == operand.substr(0, bang)) {
+          sheet = (int)s;
+        }
+      }
+      cell = operand.substr(bang + 1);
+    }
+    if (cell.size() < 2 || cell.size() > 4 || cell[0] < 'A' || cell[0] > 'Z' || cell[1] == '0' || !isDigits(cell, 1)) {
+      return { Operand::UNDECIDED, 0, 0, 0, 0 };
+    }
+    const int column = cell[0] - 'A';
+    const int row = std::stoi(cell.substr(1)) - 1;
+    if (sheet < 0 || column >= (int)m_workbook.grids[sheet][0].size() || row >= (int)m_workbook.grids[sheet].size()) {
+      return { Operand::OUTSIDE, 0, 0, 0, 0 };
+    }
+    return { Operand::CELL, 0, sheet, row, column };
+  }
+
+  // value of a referenced number or empty cell, or the error it gives
+  bool read(const Operand& operand, Expected& error, long long& value) const
+  {
+    const std::string& data = m_workbook.grids[operand.sheet][operand.row][operand.column];
+    const Expected target = evaluate(operand.sheet, operand.row, operand.column);
+    if (!target.isKnown) {
+      return false;
+    }
+    if (data.empty()) {
+      value = 0;
+    } else if (data[0] == '\'') {
+      error = { true, "#TEXT?" };
+    } else if (target.value == "#UNKNOWN_FORMAT") {
+      error = target;
+    } else if (data.size() > 11) {
+      return false;
+    } else {
+      value = std::stoll(data);
+      return value >= INT_MIN && value <= INT_MAX;
+    }
+    return true;
+  }
+
+  Expected evaluateFormula(int sheet, const std::string& data) const
+  {
+    std::string text;
+    for (size_t i = 1; i < data.size(); ++i) {
+      if (data[i] != ' ') {
+        text += (char)std::toupper(static_cast<unsigned char>(data[i]));
+      }
+    }
+    std::vector<std::string> parts;
+    for (size_t i = 0; i < text.size(); ++i) {
+      if (std::string("+-*/()").find(text[i]) != std::string::npos) {
+        parts.push_back(std::string(1, text[i]));
+      } else if (parts.empty() || std::string("+-*/()").find(parts.back()[0]) != std::string::npos) {
+        parts.push_back(std::string(1, text[i]));
+      } else {
+        parts.back() += text[i];
+      }
+    }
+
+    // a formula referring to a formula (and so any cycle) is not decided here
+    std::vector<Operand> operands;
+    for (const auto& part : parts) {
+      if (std::string("+-*/()").find(part[0]) == std::string::npos) {
+        operands.push_back(locate(sheet, part));
+        const Operand& operand = operands.back();
+        if (operand.kind == Operand::UNDECIDED || (operand.kind == Operand::CELL
+            && m_workbook.grids[operand.sheet][operand.row][operand.column].compare(0, 1, "=") == 0))
+        {
+          return { false, "" };
+        }
+      }
+    }
+
+    // operands are read left to right, the first error wins
+    std::vector<Token> tokens;
+    size_t next = 0;
+    for (const auto& part : parts) {
+      if (std::string("+-*/()").find(part[0]) != std::string::npos) {
+        tokens.push_back({ part[0], 0 });
+        continue;
+      }
+      const Operand& operand = operands[next++];
+      if (operand.kind == Operand::OUTSIDE) {
+        return { true, "#TEXT?" };
+      }
+      long long value = operand.value;
+      Expected error = { false, "" };
+      if (operand.kind == Operand::CELL && !read(operand, error, value)) {
+        return { false, "" };
+      }
+      if (error.isKnown) {
+        return error;
+      }
+      tokens.push_back({ 0, value });
+    }
+
+    size_t pos = 0;
+    bool isDivisionByZero = false;
+    long long result = 0;
+    if (!parseExpression(tokens, pos, result, isDivisionByZero) || pos != tokens.size()) {
+      return { false, "" };
+    }
+    return { true, isDivisionByZero ? "#ERROR_NUM" : std::to_string(result) };
+  }
+
+  // expression: term (operator term)*, term: value | '(' expression ')'
+  static bool parseTerm(const std::vector<Token>& tokens, size_t& pos, long long& value, bool& isDivisionByZero)
+  {
+    if (pos < tokens.size() && tokens[pos].op == 0) {
+      value = tokens[pos++].value;
+      return true;
+    }
+    if (pos < tokens.size() && tokens[pos].op == '(') {
+      ++pos;
+      if (!parseExpression(tokens, pos, value, isDivisionByZero) || pos == tokens.size() || tokens[pos].op != ')') {
+        return false;
+      }
+      ++pos;
+      return true;
+    }
+    return false;
+  }
+
+  static bool parseExpression(const std::vector<Token>& tokens, size_t& pos, long long& value, bool& isDivisionByZero)
+  {
+    if (!parseTerm(tokens, pos, value, isDivisionByZero)) {
+      return false;
+    }
+    while (pos < tokens.size() && std::string("+-*/").find(tokens[pos].op) != std::string::npos) {
+      const char op = tokens[pos++].op;
+      long long right = 0;
+      if (!parseTerm(tokens, pos, right, isDivisionByZero)) {
+        return false;
+      }
+      isDivisionByZero = isDivisionByZero || (op == '/' && right == 0);
+      value = isDivisionByZero ? 0
+            : op == '+' ? wrap(value + right)
+            : op == '-' ? wrap(value - right)
+            : op == '*' ? wrap(value * right)
+            : wrap(value / right);
+    }
+    return true;
+  }
+
+private:
+  const Workbook& m_workbook;
+};
+
+static void printInputs(const Workbook& workbook)
+{
+  for (size_t i = 0; i < workbook.inputs.size(); ++i) {
+    std::cerr << "--- input " << workbook.names[i] << "\n" << workbook.inputs[i];
+  }
+}
+
+// cells of a written sheet, by row and column
+static std::vector<std::vector<std::string>> parseOutput(const std::string& output)
+{
+  std::vector<std::vector<std::string>> rows;
+  std::istringstream lines(output);
+  std::string line;
+  for (bool isHeader = true; std::getline(lines, line); isHeader = false) {
+    if (isHeader) {
+      continue;
+    }
+    std::vector<std::string> cells;
+    size_t pos = line.find(' ') + 1;
+    for (size_t tab = line.find('\t', pos); tab != std::string::npos; tab = line.find('\t', pos)) {
+      cells.push_back(line.substr(pos, tab - pos));
+      pos = tab + 1;
+    }
+    rows.push_back(cells);
+  }
+  return rows;
+}
+
+int main(int argc, char* argv[])
+{
+  const int iterations = argc > 1 ? std::stoi(argv[1]) : 200;
+  const unsigned int seed = argc > 2 ? std::stoul(argv[2]) : 1;
+  const int maxRows = argc > 3 ? std::stoi(argv[3]) : 10;
+  rng.seed(seed);
+
+  bool isDeltaEmpty = true;
+  std::vector<Engine> engines = {
+    { "reference", [](const Workbook& w, const std::vector<std::string>& in, const std::vector<std::string>& out) {
+        return runEngine(SpreadsheetCalculator::REFERENCE, 1, w, in, out); }, 0 },
+    { "serial", [](const Workbook& w, const std::vector<std::string>& in, const std::vector<std::string>& out) {
+        return runEngine(SpreadsheetCalculator::GRAPH, 1, w, in, out); }, 0 },
+    { "parallel", [](const Workbook& w, const std::vector<std::string>& in, const std::vector<std::string>& out) {
+        return runEngine(SpreadsheetCalculator::GRAPH, 4, w, in, out); }, 0 },
+    { "incremental", [&isDeltaEmpty](const Workbook& w, const std::vector<std::string>& in, const std::vector<std::string>& out) {
+        return runIncremental(w, in, out, isDeltaEmpty); }, 0 },
+  };
+
+  const std::filesystem::path dir = std::filesystem::temp_directory_path() / ("differential_" + std::to_string(seed));
+  std::filesystem::create_directories(dir);
+  int failures = 0;
+  long long cells = 0;
+  long long decidedCells = 0;
+  for (int iteration = 0; iteration < iterations && failures == 0; ++iteration) {
+    const Workbook workbook = generateWorkbook(maxRows);
+    const Evaluator evaluator(workbook);
+    std::vector<std::vector<std::vector<Expected>>> decided;
+    for (size_t s = 0; s < workbook.grids.size(); ++s) {
+      const auto& grid = workbook.grids[s];
+      decided.emplace_back(grid.size(), std::vector<Expected>(grid[0].size()));
+      for (size_t row = 0; row < grid.size(); ++row) {
+        for (size_t column = 0; column < grid[row].size(); ++column) {
+          decided[s][row][column] = evaluator.evaluate((int)s, (int)row, (int)column);
+          ++cells;
+          decidedCells += decided[s][row][column].isKnown;
+        }
+      }
+    }
+    std::vector<std::string> expected;
+    for (auto& engine : engines) {
+      std::vector<std::string> inputs;
+      std::vector<std::string> outputs;
+      for (size_t s = 0; s < workbook.inputs.size(); ++s) {
+        const std::string base = (dir / (std::string(engine.name) + "_" + workbook.names[s])).string();
+        inputs.push_back(base + ".in.tsv");
+        outputs.push_back(base + ".out.tsv");
+        writeFile(inputs.back(), workbook.inputs[s]);
+      }
+      engine.seconds += engine.run(workbook, inputs, outputs);
+
+      for (size_t s = 0; s < outputs.size(); ++s) {
+        const std::string actual = readFile(outputs[s]);
+        const auto written = parseOutput(actual);
+        bool isShapeEqual = written.size() == decided[s].size();
+        for (size_t row = 0; row < decided[s].size() && failures == 0; ++row) {
+          isShapeEqual = isShapeEqual && written[row].size() == decided[s][row].size();
+          for (size_t column = 0; isShapeEqual && column < decided[s][row].size(); ++column) {
+            const Expected& cell = decided[s][row][column];
+            if (cell.isKnown && written[row][column] != cell.value) {
+              std::cerr << "iteration " << iteration << ", engine " << engine.name << ", sheet "
+                        << workbook.names[s] << ", cell " << cellName((int)column, (int)row + 1) << ": "
+                        << workbook.grids[s][row][column] << " gives '" << written[row][column]
+                        << "', the independent evaluator '" << cell.value << "'\n";
+              printInputs(workbook);
+              ++failures;
+            }
+          }
+        }
+        if (!isShapeEqual) {
+          std::cerr << "iteration " << iteration << ", engine " << engine.name << ", sheet "
+                    << workbook.names[s] << ": written sheet has the wrong size\n" << actual;
+          printInputs(workbook);
+          ++failures;
+        }
+        if (expected.size() <= s) {
+          expected.push_back(actual);
+        } else if (actual != expected[s]) {
+          std::cerr << "iteration " << iteration << ", engine " << engine.name << ", sheet "
+                    << workbook.names[s] << ": output differs from the reference engine\n";
+          printInputs(workbook);
+          std::cerr << "--- expected\n" << expected[s] << "--- actual\n" << actual;
+          ++failures;
+        }
+      }
+      if (!isDeltaEmpty) {
+        std::cerr << "iteration " << iteration << ": delta after a full write is not empty\n";
+        isDeltaEmpty = true;
+        ++failures;
+      }
+    }
+  }
+  std::filesystem::remove_all(dir);
+
+  std::cout << "engine        total ms   ms/workbook\n";
+  for (const auto& engine : engines) {
+    std::cout << "  " << engine.name << std::string(12 - std::string(engine.name).size(), ' ')
+              << engine.seconds * 1000 << "   " << engine.seconds * 1000 / iterations << "\n";
+  }
+  std::cout << "independent evaluator decided " << decidedCells << " of " << cells << " cells\n";
+  if (failures != 0) {
+    std::cerr << "DifferentialTest: FAILED (seed " << seed << ")\n";
+    return 1;
+  }
+  std::cout << "DifferentialTest: OK, " << iterations << " workbooks (seed " << seed << ")\n";
+  return 0;
+}
@@ -0,0 +1,96 @@
+// Pins the sheet output to what the evaluator produced before the switch
+// to NumberConverter (baseline std::stoi/std::ostringstream evaluator).
+// g++ -std=c++17 -pthread -o GoldenOutputTest tests/GoldenOutputTest.cpp src/*.cpp
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../src/SpreadsheetCalculator.h"
+
+struct GoldenCase
+{
+  const char* name;
+  const char* input;
+  const char* expected;
+};
+
+static const GoldenCase cases[] = {
+  { "numbers_text_expressions",
+    "3\t3\r\n"
+    "12\t'Hello\t=1+2*3\r\n"
+    "007\t\t=(4-1)/0\r\n"
+    "text\t-5\t=((2)\r\n",
+    "  A\tB\tC\t\n"
+    "1 12\tHello\t9\t\n"
+    "2 7\t\t#ERROR_NUM\t\n"
+    "3 #UNKNOWN_FORMAT\t-5\t#WRONG_FORMULA_TYPE\t\n" },
+  { "references",
+    "2\t4\r\n"
+    "5\t=a1+3\t=D1*2\t=4*4\r\n"
+    "'x\t=A2+1\t=A9\t=A1-D1\r\n",
+    "  A\tB\tC\tD\t\n"
+    "1 5\t8\t32\t16\t\n"
+    "2 x\t#TEXT?\t#TEXT?\t-11\t\n" },
+  { "arithmetic",
+    "2\t3\r\n"
+    "=10/3\t=2-7\t=(1+2)*(3+4)\r\n"
+    "=-4\t=  8 * 2 \t'a b\r\n",
+    "  A\tB\tC\t\n"
+    "1 3\t-5\t21\t\n"
+    "2 -4\t16\ta b\t\n" },
+  { "unnamed_sheet_reference",
+    "2\t2\r\n"
+    "1\t2\r\n"
+    "5\t=!A1+1\r\n",
+    "  A\tB\t\n"
+    "1 1\t2\t\n"
+    "2 5\t#TEXT?\t\n" },
+  // rejected as invalid content before the reader split rows on every tab
+  { "empty_last_cell",
+    "2\t2\r\n"
+    "5\t\r\n"
+    "\t=B1+A1\r\n",
+    "  A\tB\t\n"
+    "1 5\t\t\n"
+    "2 \t5\t\n" },
+};
+
+static std::string readFile(const std::string& filename)
+{
+  std::ifstream file(filename);
+  std::ostringstream s;
+  s << file.rdbuf();
+  return s.str();
+}
+
+int main()
+{
+  const std::filesystem::path dir = std::filesystem::temp_directory_path();
+  int failures = 0;
+  for (const auto& c : cases) {
+    const std::string input = (dir / (std::string(c.name) + ".in.tsv")).string();
+    const std::string output = (dir / (std::string(c.name) + ".out.tsv")).string();
+    std::ofstream(input, std::ios::binary) << c.input;
+
+    SpreadsheetCalculator calculator(input.c_str(), output.c_str());
+    calculator.readDataFromInputFile();
+    calculator.writeCalculatedDataToOutputFile();
+
+    const std::string actual = readFile(output);
+    if (actual != c.expected) {
+      std::cerr << c.name << ": output differs\n--- expected\n" << c.expected << "--- actual\n" << actual;
+      ++failures;
+    }
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+  }
+  if (failures != 0) {
+    std::cerr << failures << " case(s) failed\n";
+    return 1;
+  }
+  std::cout << "GoldenOutputTest: OK\n";
+  return 0;
+}
@@ -0,0 +1,88 @@
+// Round-trip and edge case checks for NumberConverter.
+// g++ -std=c++17 -o NumberConverterTest tests/NumberConverterTest.cpp src/NumberConverter.cpp
+
+#include <climits>
+#include <iostream>
+#include <string>
+
+#include "../src/NumberConverter.h"
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n"; \
+      ++failures; \
+    } \
+  } while (0)
+
+static bool parses(const std::string& data, int expected)
+{
+  int value = 0;
+  return NumberConverter::parse(data, value) && value == expected;
+}
+
+static bool rejects(const std::string& data)
+{
+  int value = 42;
+  return !NumberConverter::parse(data, value);
+}
+
+int main()
+{
+  // accepted forms, std::stoi accepted them too
+  CHECK(parses("0", 0));
+  CHECK(parses("7", 7));
+  CHECK(parses("-7", -7));
+  CHECK(parses("+7", 7));
+  CHECK(parses("007", 7));
+  CHECK(parses("-007", -7));
+  CHECK(parses("2147483647", INT_MAX));
+  CHECK(parses("-2147483648", INT_MIN));
+  CHECK(parses("+2147483647", INT_MAX));
+
+  // rejected forms: std::stoi threw or silently ignored a suffix
+  CHECK(rejects(""));
+  CHECK(rejects("+"));
+  CHECK(rejects("-"));
+  CHECK(rejects("+-7"));
+  CHECK(rejects("-+7"));
+  CHECK(rejects("++7"));
+  CHECK(rejects("7a"));
+  CHECK(rejects(" 7"));
+  CHECK(rejects("2147483648"));
+  CHECK(rejects("-2147483649"));
+  CHECK(rejects("99999999999999999999"));
+
+  // pointer range overload only looks at [first, last)
+  {
+    const std::string data = "A123";
+    int value = 0;
+    CHECK(NumberConverter::parse(data.data() + 1, data.data() + data.size(), value) && value == 123);
+    CHECK(!NumberConverter::parse(data.data(), data.data() + data.size(), value));
+  }
+
+  // formatting matches std::to_string
+  const int values[] = { 0, 1, -1, 9, 10, -10, 12345, -12345, INT_MAX, INT_MIN };
+  for (int v : values) {
+    CHECK(NumberConverter::toString(v) == std::to_string(v));
+    int back = 0;
+    CHECK(NumberConverter::parse(NumberConverter::toString(v), back) && back == v);
+  }
+
+  // append keeps the existing content
+  {
+    std::string line = "row ";
+    NumberConverter::append(line, -42);
+    NumberConverter::append(line, 7);
+    CHECK(line == "row -427");
+  }
+
+  if (failures != 0) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "NumberConverterTest: OK\n";
+  return 0;
+}